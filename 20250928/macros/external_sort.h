@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// external_sort.h — Bounded-Memory Grouping of Per-File CSV Rows by Run
+//
+// Hands every run's rows of a per-file CSV (run,segment,file,value,...) to a
+// callback, ordered by (run, segment, input order): the same groups and order
+// as reading everything into memory and stable-sorting, at bounded memory.
+//
+//  1. Rows are read into a buffer of at most mem_mb. The buffer counts its
+//     allocated capacity, including the transient old + new block while it
+//     grows, plus the heap owned by each row (Codec::heap_bytes). A full
+//     buffer is sorted and spilled to out/_spill/.
+//  2. While more than kMaxFanIn chunks exist, groups of kMaxFanIn are merged
+//     into one (multi-level merge), so at most kMaxFanIn spill files are open
+//     at any time whatever the input size.
+//  3. The last <= kMaxFanIn chunks are k-way merged straight into the callback.
+//
+// The row type needs int run, seg and long seq; the codec parses input lines
+// and writes / reads spill lines:
+//   struct Codec {
+//     static bool parse(const std::string& csv_line, Row& r);
+//     static void write(std::ostream& o, const Row& r);
+//     static bool read(const std::string& spill_line, Row& r);
+//     static size_t heap_bytes(const Row& r);
+//   };
+//
+// Usage (inside a macro):
+//   #include "external_sort.h"
+//   xsort::Stats st;
+//   xsort::for_each_run<Row, Codec>(path, mem_mb, tag,
+//       [&](int run, const std::vector<Row>& rows){ ... }, &st);
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_EXTERNAL_SORT_H
+#define QA_EXTERNAL_SORT_H
+
+#include <TSystem.h>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace xsort {
+
+// spill files open at once during a merge
+static const size_t kMaxFanIn = 64;
+
+struct Stats { long rows = 0; size_t chunks = 0; int levels = 0; };
+
+template <class Row>
+static bool row_less(const Row& a, const Row& b) {
+  if (a.run != b.run) return a.run < b.run;
+  if (a.seg != b.seg) return a.seg < b.seg;
+  return a.seq < b.seq;
+}
+
+// k-way merge of sorted spill files; out(row) receives rows in order
+template <class Row, class Codec, class Out>
+static void merge(const std::vector<std::string>& chunks, Out out) {
+  std::vector<std::unique_ptr<std::ifstream>> rd;
+  std::vector<Row> head(chunks.size());
+  auto next = [&](size_t i) {
+    std::string s;
+    return std::getline(*rd[i], s) && Codec::read(s, head[i]);
+  };
+  auto cmp = [&](size_t a, size_t b){ return row_less(head[b], head[a]); };   // min-heap
+  std::priority_queue<size_t, std::vector<size_t>, decltype(cmp)> pq(cmp);
+  for (size_t i=0; i<chunks.size(); ++i) {
+    rd.emplace_back(new std::ifstream(chunks[i]));
+    if (next(i)) pq.push(i);
+  }
+  while (!pq.empty()) {
+    size_t i = pq.top(); pq.pop();
+    out(head[i]);
+    if (next(i)) pq.push(i);
+  }
+}
+
+template <class Row, class Codec, class Fn>
+static bool for_each_run(const std::string& path, double mem_mb, const std::string& tag, Fn fn,
+                         Stats* stats = nullptr) {
+  std::ifstream in(path);
+  if (!in) return false;
+  gSystem->mkdir("out/_spill", kTRUE);
+  const double budget = std::max(1.0, mem_mb) * 1024.0 * 1024.0;
+  std::vector<std::string> chunks;
+  size_t nspill = 0;
+  auto chunk_path = [&]() { return "out/_spill/" + tag + "_" + std::to_string(nspill++) + ".csv"; };
+
+  // ---- 1. sorted runs of at most the budget ----
+  std::vector<Row> buf;
+  double heap = 0;   // bytes owned by the buffered rows beyond sizeof(Row)
+  long seq = 0;
+  auto spill = [&]() {
+    if (buf.empty()) return;
+    std::sort(buf.begin(), buf.end(), row_less<Row>);
+    chunks.push_back(chunk_path());
+    std::ofstream o(chunks.back());
+    o.precision(17);
+    for (auto& r : buf) Codec::write(o, r);
+    buf.clear(); heap = 0;   // capacity is kept and stays counted
+  };
+  std::string s; bool first = true;
+  while (std::getline(in, s)) {
+    if (first) { first = false; continue; }
+    if (s.empty()) continue;
+    Row r;
+    if (!Codec::parse(s, r)) continue;
+    r.seq = seq++;
+    if (buf.size() == buf.capacity()) {
+      // grow by hand: during reallocation the old and the new block are both live
+      const double rows_fit = (budget - heap) / sizeof(Row);
+      const size_t room = rows_fit > buf.capacity() ? (size_t)(rows_fit - buf.capacity()) : 0;
+      const size_t want = std::min(std::max<size_t>(64, 2 * buf.capacity()), room);
+      if (want > buf.size()) buf.reserve(want);
+      else { spill(); if (buf.capacity() == 0) buf.reserve(1); }
+    }
+    heap += Codec::heap_bytes(r);
+    buf.push_back(std::move(r));
+    if (buf.capacity() * sizeof(Row) + heap >= budget) spill();
+  }
+  spill();
+  std::vector<Row>().swap(buf);
+  if (chunks.empty()) return false;
+  const size_t nchunks = chunks.size();
+
+  // ---- 2. bounded fan-in: merge kMaxFanIn chunks at a time until few enough remain ----
+  int levels = 0;
+  while (chunks.size() > kMaxFanIn) {
+    std::vector<std::string> next;
+    for (size_t i=0; i<chunks.size(); i+=kMaxFanIn) {
+      std::vector<std::string> group(chunks.begin()+i, chunks.begin()+std::min(chunks.size(), i+kMaxFanIn));
+      if (group.size() == 1) { next.push_back(group[0]); continue; }
+      next.push_back(chunk_path());
+      {
+        std::ofstream o(next.back());
+        o.precision(17);
+        merge<Row, Codec>(group, [&](const Row& r){ Codec::write(o, r); });
+      }
+      for (auto& cp : group) gSystem->Unlink(cp.c_str());
+    }
+    chunks.swap(next);
+    ++levels;
+  }
+
+  // ---- 3. final merge, one run at a time ----
+  std::vector<Row> run_rows;
+  merge<Row, Codec>(chunks, [&](const Row& r) {
+    if (!run_rows.empty() && run_rows.back().run != r.run) { fn(run_rows.front().run, run_rows); run_rows.clear(); }
+    run_rows.push_back(r);
+  });
+  if (!run_rows.empty()) fn(run_rows.front().run, run_rows);
+  for (auto& cp : chunks) gSystem->Unlink(cp.c_str());
+  if (stats) { stats->rows = seq; stats->chunks = nchunks; stats->levels = levels + 1; }
+  return true;
+}
+
+} // namespace xsort
+
+#endif // QA_EXTERNAL_SORT_H
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// hist_kernels.h — Shared Per-Histogram Metric Kernels
+//
+// The methods of metrics.conf, evaluated on one histogram of one file:
+//   maxbin, median (p50), p90 (quantilep90), mean, rms, asym,
+//   ks_uniform_p, chi2_uniform_red
+// extract_metrics_v2.C fills the per-file CSVs with them and reextract_run.C
+// re-evaluates single runs with them, so both agree value for value. Method
+// names are case-insensitive; normalize_method() gives the canonical spelling.
+// Kernels return a value only: the per-file error column is 0 for all of
+// them (fit-based metrics come from physqa_extract.C).
+//
+// norm_cdf() / ks_distance() compare histogram shapes; the fit caches of
+// physqa_extract.C and fit_quality.C reuse a fit when the distance is small.
+//
+// Usage (inside a macro):
+//   #include "hist_kernels.h"
+//   const std::string m = hkern::normalize_method(" P50 ");   // "median"
+//   if (hkern::known(m)) double v = hkern::evaluate(h, m);
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_HIST_KERNELS_H
+#define QA_HIST_KERNELS_H
+
+#include <TH1.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hkern {
+
+static const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// trimmed, lowercased, aliases resolved
+static std::string normalize_method(std::string m) {
+  auto sp = [](unsigned char c){ return !std::isspace(c); };
+  m.erase(m.begin(), std::find_if(m.begin(), m.end(), sp));
+  m.erase(std::find_if(m.rbegin(), m.rend(), sp).base(), m.end());
+  std::transform(m.begin(), m.end(), m.begin(), [](unsigned char c){ return std::tolower(c); });
+  if (m == "p50") m = "median";
+  if (m == "quantilep90") m = "p90";
+  return m;
+}
+
+static bool known(const std::string& m) {
+  return m == "maxbin" || m == "median" || m == "p90" || m == "mean" || m == "rms" || m == "asym" ||
+         m == "ks_uniform_p" || m == "chi2_uniform_red";
+}
+
+// flat histogram with the same binning and integral
+static TH1* uniform_like(const TH1* h, const char* name) {
+  int nb = h->GetXaxis()->GetNbins();
+  TH1* u = (TH1*)h->Clone(name);
+  u->SetDirectory(nullptr);
+  u->Reset("ICESM");
+  double per = nb > 0 ? h->Integral(1, nb) / nb : 0.0;
+  for (int i=1; i<=nb; ++i) u->SetBinContent(i, per);
+  return u;
+}
+
+static double quantile(TH1* h, double q) {
+  double x = kNaN, qq = q;
+  if (h->GetEntries() <= 0) return kNaN;
+  h->GetQuantiles(1, &x, &qq);
+  return x;
+}
+
+// (max - min) / (max + min) of the bin contents
+static double asym(TH1* h) {
+  int nb = h->GetXaxis()->GetNbins();
+  if (nb <= 0) return kNaN;
+  double mx = h->GetBinContent(1), mn = mx;
+  for (int i=2; i<=nb; ++i) { mx = std::max(mx, h->GetBinContent(i)); mn = std::min(mn, h->GetBinContent(i)); }
+  return (mx + mn) > 0 ? (mx - mn) / (mx + mn) : kNaN;
+}
+
+// method must be normalized; NaN for an unknown method and, except maxbin (which has
+// always reported the first bin of an empty histogram), for an empty histogram
+static double evaluate(TH1* h, const std::string& m) {
+  if (!h) return kNaN;
+  if (m == "maxbin") return h->GetXaxis()->GetBinCenter(h->GetMaximumBin());
+  if (h->GetEntries() <= 0) return kNaN;
+  if (m == "median") return quantile(h, 0.50);
+  if (m == "p90")    return quantile(h, 0.90);
+  if (m == "mean")   return h->GetMean();
+  if (m == "rms")    return h->GetRMS();
+  if (m == "asym")   return asym(h);
+  if (m == "ks_uniform_p") {
+    std::unique_ptr<TH1> u(uniform_like(h, "__hk_u_ks"));
+    return h->KolmogorovTest(u.get(), "N");
+  }
+  if (m == "chi2_uniform_red") {
+    std::unique_ptr<TH1> u(uniform_like(h, "__hk_u_chi"));
+    return h->Chi2Test(u.get(), "CHI2/NDF");
+  }
+  return kNaN;
+}
+
+// normalised cumulative distribution over the in-range bins
+static std::vector<double> norm_cdf(TH1* h) {
+  const int nb = h->GetNbinsX();
+  std::vector<double> c(nb, 0.0);
+  double acc = 0, tot = h->Integral(1, nb);
+  for (int i=1; i<=nb; ++i) { acc += h->GetBinContent(i); c[i-1] = tot > 0 ? acc / tot : 0; }
+  return c;
+}
+
+// max |a - b| of two norm_cdf()s (Kolmogorov distance); NaN for different binnings
+static double ks_distance(const std::vector<double>& a, const std::vector<double>& b) {
+  if (a.size() != b.size()) return kNaN;
+  double d = 0;
+  for (size_t i=0; i<a.size(); ++i) d = std::max(d, std::fabs(a[i] - b[i]));
+  return d;
+}
+
+} // namespace hkern
+
+#endif // QA_HIST_KERNELS_H
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// perf_log.h — Append-Only Performance Log of Pipeline Stages
+//
+// Stages that read input files append one row per invocation to
+// out/perf_log.csv with what they read and how long it took:
+//   timestamp,stage,event,files,hists,bytes,fits,wall_s,detail
+// event is "done" for a completed stage; other events (e.g. deadline
+// deferrals) carry their context in detail. plan_pipeline.C fits its per-stage
+// cost model to the "done" rows and compares plans against them.
+//
+// Usage (inside a macro):
+//   #include "perf_log.h"
+//   perflog::Timer t;
+//   ...
+//   perflog::append("extract", "done", nfiles, nhists, nbytes, nfits, t.seconds());
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_PERF_LOG_H
+#define QA_PERF_LOG_H
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+namespace perflog {
+
+static const char* kPath = "out/perf_log.csv";
+
+struct Timer {
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+};
+
+inline void append(const std::string& stage, const std::string& event,
+                   long files, long hists, long long bytes, long fits, double wall_s,
+                   const std::string& detail = "") {
+  bool fresh = !std::ifstream(kPath).good();
+  std::ofstream o(kPath, std::ios::app);
+  if (fresh) o << "timestamp,stage,event,files,hists,bytes,fits,wall_s,detail\n";
+  o << (long)std::time(nullptr) << "," << stage << "," << event << "," << files << "," << hists << ","
+    << bytes << "," << fits << "," << wall_s << "," << detail << "\n";
+}
+
+} // namespace perflog
+
+#endif // QA_PERF_LOG_H
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// resource_governor.h — Memory and Thread Budgets for Shared Batch Nodes
+//
+// One budget for the whole pipeline, taken from the environment (the Makefile
+// exports MEM_MB / THREADS as these):
+//   QA_MEM_MB   — resident-memory budget per stage in MB (0 = unlimited)
+//   QA_THREADS  — threads any stage may use (0 = unlimited)
+//
+// A stage asks the governor for
+//   threads(n)    — n clamped to the thread budget (n <= 0: all cores, clamped)
+//   chunk_mb(mb)  — memory for in-memory chunks when the stage has none set:
+//                   half the budget, leaving the rest for ROOT and the stage
+//   acquire()/release() — a slot for one in-flight input file; the number of
+//                   slots adapts to the process RSS (read via GetProcInfo):
+//                   halved when RSS passes 90% of the budget, grown back by one
+//                   once it is under 70%
+//   pressure()    — whether RSS is past 90% of the budget, so the stage can
+//                   drop caches
+//
+// Every change of the slot count and every cache drop is a "throttle" row in
+// out/perf_log.csv (see perf_log.h), with the RSS and the action in detail.
+//
+// Usage (inside a macro):
+//   #include "resource_governor.h"
+//   govern::Governor gov("extract");
+//   nworkers = gov.threads(nworkers);
+//   gov.open_slots(nworkers);
+//   ... gov.acquire(); process(file); gov.release(); ...
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_RESOURCE_GOVERNOR_H
+#define QA_RESOURCE_GOVERNOR_H
+
+#include "perf_log.h"
+
+#include <TSystem.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace govern {
+
+static const double kHigh = 0.90;   // fraction of the budget that triggers throttling
+static const double kLow  = 0.70;   // fraction below which slots are given back
+
+inline long env_long(const char* name) {
+  const char* v = gSystem->Getenv(name);
+  return (v && *v) ? std::max(0L, std::atol(v)) : 0;
+}
+
+// resident set size of this process in MB (0 if unavailable)
+inline double rss_mb() {
+  ProcInfo_t pi;
+  if (gSystem->GetProcInfo(&pi) < 0) return 0;
+  return pi.fMemResident / 1024.0;
+}
+
+class Governor {
+ public:
+  explicit Governor(const std::string& stage)
+      : stage_(stage), mem_mb_(env_long("QA_MEM_MB")), threads_(env_long("QA_THREADS")) {
+    if (mem_mb_ > 0 || threads_ > 0)
+      std::cout << "[GOVERN] " << stage_ << ": memory budget "
+                << (mem_mb_ > 0 ? std::to_string(mem_mb_) + " MB" : std::string("unlimited"))
+                << ", thread budget " << (threads_ > 0 ? std::to_string(threads_) : std::string("unlimited")) << "\n";
+  }
+
+  long mem_mb() const { return mem_mb_; }
+
+  int threads(int requested) const {
+    int n = requested > 0 ? requested : (int)std::max(1u, std::thread::hardware_concurrency());
+    if (threads_ > 0) n = std::min<long>(n, threads_);
+    return std::max(1, n);
+  }
+
+  double chunk_mb(double requested) const {
+    if (requested > 0 || mem_mb_ <= 0) return requested;
+    return 0.5 * mem_mb_;
+  }
+
+  void open_slots(int n) {
+    std::lock_guard<std::mutex> lk(m_);
+    max_slots_ = slots_ = std::max(1, n);
+  }
+
+  void acquire() {
+    std::unique_lock<std::mutex> lk(m_);
+    cv_.wait(lk, [&]{ return inflight_ < slots_; });
+    ++inflight_;
+  }
+
+  // frees the slot, then re-reads RSS and adapts the slot count
+  void release() {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      --inflight_;
+      if (mem_mb_ > 0) {
+        const double rss = rss_mb();
+        const int before = slots_;
+        if (rss > kHigh * mem_mb_ && slots_ > 1) slots_ = std::max(1, slots_ / 2);
+        else if (rss < kLow * mem_mb_ && slots_ < max_slots_) ++slots_;
+        if (slots_ != before) {
+          const bool down = slots_ < before;
+          std::ostringstream d;
+          d << (down ? "slots_down" : "slots_up") << "=" << before << "->" << slots_;
+          log_locked(down ? "throttle" : "resume", rss, d.str());
+        }
+      }
+    }
+    cv_.notify_all();
+  }
+
+  bool pressure() const { return mem_mb_ > 0 && rss_mb() > kHigh * mem_mb_; }
+
+  // records a stage-specific reaction to pressure (e.g. "cache_drop=412")
+  void note(const std::string& action) {
+    std::lock_guard<std::mutex> lk(m_);
+    log_locked("throttle", rss_mb(), action);
+  }
+
+  int events() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return events_;
+  }
+
+ private:
+  void log_locked(const std::string& event, double rss, const std::string& action) {
+    ++events_;
+    std::ostringstream d;
+    d << "rss_mb=" << (long)rss << ";limit_mb=" << mem_mb_ << ";" << action;
+    perflog::append(stage_, event, 0, 0, 0, 0, 0, d.str());
+    std::cout << "[GOVERN] " << stage_ << " " << event << ": " << d.str() << "\n";
+  }
+
+  std::string stage_;
+  long mem_mb_ = 0, threads_ = 0;
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  int slots_ = 1, max_slots_ = 1, inflight_ = 0, events_ = 0;
+};
+
+} // namespace govern
+
+#endif // QA_RESOURCE_GOVERNOR_H
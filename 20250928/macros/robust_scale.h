@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// robust_scale.h — Shared Robust Scale Estimators (MAD, Qn, Sn)
+//
+// All estimators return a Gaussian-consistent sigma, so they can replace
+// 1.4826*MAD one for one:
+//   mad — 1.4826 * median |x - med|        (37% Gaussian efficiency)
+//   qn  — Croux-Rousseeuw Qn: k-th order statistic of |x_i - x_j|, i<j,
+//         k = C(n/2+1, 2)                  (82% efficiency, no location)
+//   sn  — Croux-Rousseeuw Sn: lomed_i himed_j |x_i - x_j|
+//                                          (58% efficiency, no location)
+//
+// Maxbin-based metrics (intt_adc_peak, intt_bco_peak) are discretized: MAD
+// moves in whole bins and is zero as soon as half the window shares a bin.
+// Qn and Sn use all pairwise differences, so they resolve the spread far
+// better. When even they are zero (one bin holds most of the window), sigma()
+// floors the qn/sn scale at the quantization noise of the data, spacing/sqrt(12),
+// instead of letting z explode. The mad path is unchanged.
+//
+// Both run in O(n log n): Sn takes each inner median by selection in two
+// sorted runs, and Qn selects its order statistic in the implicit sorted
+// matrix of differences with weighted-median pivots; each pivot is found by
+// selection in linear time, and O(log n) pivots are needed. Windows of any size
+// can be passed, so the functions serve sliding-window baselines as well.
+// Small-sample correction factors follow Croux & Rousseeuw (1992).
+//
+// Usage (inside a macro):
+//   #include "robust_scale.h"
+//   double s = rscale::sigma(values, "qn");          // mad | qn | sn
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_ROBUST_SCALE_H
+#define QA_ROBUST_SCALE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace rscale {
+
+inline double median(std::vector<double> v) {
+  if (v.empty()) return std::numeric_limits<double>::quiet_NaN();
+  size_t n = v.size(); std::nth_element(v.begin(), v.begin() + n/2, v.end());
+  double m = v[n/2];
+  if (n % 2 == 0) { std::nth_element(v.begin(), v.begin() + n/2 - 1, v.end()); m = 0.5*(m + v[n/2 - 1]); }
+  return m;
+}
+
+inline double mad_sigma(const std::vector<double>& v) {
+  double med = median(v);
+  std::vector<double> d(v.size());
+  for (size_t i = 0; i < v.size(); ++i) d[i] = std::fabs(v[i] - med);
+  return 1.4826 * median(d);
+}
+
+// k-th smallest (0-based) of the union of two ascending sequences a(0..na-1), b(0..nb-1)
+template <class A, class B>
+inline double kth_of_two(A a, long na, B b, long nb, long k) {
+  long lo = std::max(0L, k - nb), hi = std::min(k, na);   // elements taken from a
+  while (lo < hi) {
+    long i = (lo + hi) / 2, j = k - i;
+    if (a(i) < b(j - 1)) lo = i + 1; else hi = i;
+  }
+  long i = lo, j = k - lo;
+  double va = (i < na) ? a(i) : std::numeric_limits<double>::infinity();
+  double vb = (j < nb) ? b(j) : std::numeric_limits<double>::infinity();
+  return std::min(va, vb);
+}
+
+// Sn = c_n * 1.1926 * lomed_i himed_j |x_i - x_j|
+inline double sn(std::vector<double> x) {
+  const long n = (long)x.size();
+  if (n < 2) return std::numeric_limits<double>::quiet_NaN();
+  std::sort(x.begin(), x.end());
+  std::vector<double> inner(n);
+  const long kh = n / 2;          // himed over j (incl. j = i): (n/2+1)-th smallest, 0-based n/2
+  for (long i = 0; i < n; ++i) {
+    if (kh == 0) { inner[i] = 0; continue; }   // the j = i term is the smallest
+    auto left  = [&](long t){ return x[i] - x[i - 1 - t]; };   // ascending, i terms
+    auto right = [&](long t){ return x[i + 1 + t] - x[i]; };   // ascending, n-1-i terms
+    inner[i] = kth_of_two(left, i, right, n - 1 - i, kh - 1);
+  }
+  const long kl = (n + 1) / 2 - 1;   // lomed over i
+  std::nth_element(inner.begin(), inner.begin() + kl, inner.end());
+  static const double cn[] = {0, 0, 0.743, 1.851, 0.954, 1.351, 0.993, 1.198, 1.005, 1.131};
+  double c = (n <= 9) ? cn[n] : ((n % 2) ? n / (n - 0.9) : 1.0);
+  return c * 1.1926 * inner[kl];
+}
+
+// high weighted median of (value, weight) pairs: smallest value whose
+// cumulative weight exceeds half the total; expected linear time by selection
+inline double whimed(std::vector<std::pair<double, long>> vw) {
+  long total = 0;
+  for (auto& p : vw) total += p.second;
+  using VW = std::pair<double, long>;
+  auto first = vw.begin(), last = vw.end();
+  long below = 0;                                 // weight of values already ruled out as too small
+  while (first != last) {
+    auto mid = first + (last - first) / 2;
+    std::nth_element(first, mid, last, [](const VW& a, const VW& b){ return a.first < b.first; });
+    const double t = mid->first;
+    auto lt = std::partition(first, last, [t](const VW& p){ return p.first < t; });   // < t | == t | > t
+    auto le = std::partition(lt, last, [t](const VW& p){ return p.first == t; });
+    long wl = 0, we = 0;
+    for (auto it = first; it != lt; ++it) wl += it->second;
+    for (auto it = lt; it != le; ++it) we += it->second;
+    if (2 * (below + wl) > total) last = lt;
+    else if (2 * (below + wl + we) > total) return t;
+    else { below += wl + we; first = le; }
+  }
+  return vw.empty() ? std::numeric_limits<double>::quiet_NaN() : vw.back().first;
+}
+
+inline double qn_factor(long n) {
+  static const double dn[] = {0, 0, 0.399, 0.994, 0.512, 0.844, 0.611, 0.857, 0.669, 0.872};
+  return (n <= 9) ? dn[n] : ((n % 2) ? n / (n + 1.4) : n / (n + 3.8));
+}
+
+// Qn = d_n * 2.2219 * {|x_i - x_j|; i < j}_(k), k = C(h,2), h = n/2 + 1
+inline double qn(std::vector<double> x) {
+  const long n = (long)x.size();
+  if (n < 2) return std::numeric_limits<double>::quiet_NaN();
+  std::sort(x.begin(), x.end());
+  const long h = n / 2 + 1;
+  const long k = h * (h - 1) / 2;                 // 1-based rank among n(n-1)/2 differences
+
+  // row i holds x[j] - x[i] for j = i+1..n-1 (ascending); candidates are columns lo[i]..hi[i]
+  std::vector<long> lo(n), hi(n), P(n), Q(n);
+  long below = 0, cand = 0;                       // differences ruled out as too small; candidates left
+  for (long i = 0; i < n; ++i) { lo[i] = i + 1; hi[i] = n - 1; cand += n - 1 - i; }
+
+  while (cand > n) {
+    std::vector<std::pair<double, long>> vw;
+    for (long i = 0; i < n; ++i)
+      if (lo[i] <= hi[i]) vw.push_back({x[lo[i] + (hi[i] - lo[i]) / 2] - x[i], hi[i] - lo[i] + 1});
+    const double trial = whimed(vw);
+
+    // per row: columns with difference < trial (P) and <= trial (Q); both move right with i
+    long sumP = 0, sumQ = 0, jp = 1, jq = 1;
+    for (long i = 0; i < n; ++i) {
+      jp = std::max(jp, i + 1); jq = std::max(jq, i + 1);
+      while (jp < n && x[jp] - x[i] <  trial) ++jp;
+      while (jq < n && x[jq] - x[i] <= trial) ++jq;
+      P[i] = jp - i - 1; Q[i] = jq - i - 1;
+      sumP += P[i]; sumQ += Q[i];
+    }
+    if (k > sumP && k <= sumQ) return qn_factor(n) * 2.2219 * trial;   // trial is the k-th
+    for (long i = 0; i < n; ++i) {
+      if (k <= sumP) hi[i] = std::min(hi[i], i + P[i]);
+      else           lo[i] = std::max(lo[i], i + Q[i] + 1);
+    }
+    below = 0; cand = 0;
+    for (long i = 0; i < n; ++i) {
+      below += lo[i] - i - 1;
+      if (lo[i] <= hi[i]) cand += hi[i] - lo[i] + 1;
+    }
+  }
+
+  std::vector<double> rest;
+  rest.reserve(cand);
+  for (long i = 0; i < n; ++i)
+    for (long j = lo[i]; j <= hi[i]; ++j) rest.push_back(x[j] - x[i]);
+  const long r = k - below - 1;
+  std::nth_element(rest.begin(), rest.begin() + r, rest.end());
+  return qn_factor(n) * 2.2219 * rest[r];
+}
+
+// quantization noise of discretized data: smallest nonzero spacing / sqrt(12), 0 if none
+inline double resolution_floor(std::vector<double> v) {
+  std::sort(v.begin(), v.end());
+  double d = std::numeric_limits<double>::infinity();
+  for (size_t i = 1; i < v.size(); ++i) if (v[i] > v[i-1]) d = std::min(d, v[i] - v[i-1]);
+  return std::isfinite(d) ? d / std::sqrt(12.0) : 0.0;
+}
+
+inline bool valid_method(const std::string& m) { return m == "mad" || m == "qn" || m == "sn"; }
+
+// Gaussian-consistent scale of v by method (mad | qn | sn); unknown methods fall back to mad
+inline double sigma(const std::vector<double>& v, const std::string& method) {
+  if (method != "qn" && method != "sn") return mad_sigma(v);
+  double s = (method == "qn") ? qn(v) : sn(v);
+  return (s > 0) ? s : resolution_floor(v);
+}
+
+} // namespace rscale
+
+#endif // QA_ROBUST_SCALE_H
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+// run_conditions.h — Shared Run-Conditions Table
+//
+// Run metadata (fill, beam species, magnet state, trigger configuration,
+// duration, events, start time) for the QA macros. The source is a CSV dump
+// exported from the run database, so no live service is queried:
+//
+//   run,fill,species,magnet,trigger,duration_s,events,start_time
+//
+// start_time is the run start in unix seconds; dumps without the column
+// still load, with start_time = 0 (unknown) for every run.
+//
+// The first stage that needs the table converts the dump into a
+// fixed-record binary cache (out/<dump stem>.bin); every later stage
+// loads that cache in one read, without text parsing, and looks runs up by
+// binary search on the run-sorted records. The cache is rebuilt whenever
+// the CSV is newer or the cache was written in an older record layout.
+//
+// Usage (inside a macro):
+//   #include "run_conditions.h"
+//   runcond::Table rc;
+//   if (rc.load("configs/run_conditions.csv")) { auto* c = rc.find(run); ... }
+//   std::string k = rc.key(run, "species,magnet");   // "pp|on", "" if unknown
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef QA_RUN_CONDITIONS_H
+#define QA_RUN_CONDITIONS_H
+
+#include <TSystem.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace runcond {
+
+struct Conditions {
+  int run = -1;
+  int fill = -1;
+  char species[16] = {0};
+  char magnet[8] = {0};
+  char trigger[32] = {0};
+  double duration_s = 0;
+  long long events = 0;
+  long long start_time = 0;   // unix seconds, 0 = unknown
+};
+
+// bumped whenever Conditions changes, so caches of another layout are rebuilt
+static const char kMagic[8] = {'Q','A','R','C','O','N','D','2'};
+
+inline std::string trim(std::string s) {
+  auto f = [](unsigned char c){ return !std::isspace(c); };
+  s.erase(s.begin(), std::find_if(s.begin(), s.end(), f));
+  s.erase(std::find_if(s.rbegin(), s.rend(), f).base(), s.end());
+  return s;
+}
+
+inline long mtime(const char* path) {
+  FileStat_t st;
+  return gSystem->GetPathInfo(path, st) == 0 ? st.fMtime : -1;
+}
+
+class Table {
+public:
+  // Loads the binary cache, (re)building it from csv first when it is missing or stale.
+  // The cache defaults to out/<csv stem>.bin so different dumps never share one.
+  bool load(const char* csv = "configs/run_conditions.csv", const char* cache_path = "") {
+    rows_.clear();
+    std::string cache_s = cache_path ? cache_path : "";
+    if (cache_s.empty()) {
+      std::string stem = csv;
+      stem = stem.substr(stem.find_last_of('/') + 1);
+      cache_s = "out/" + stem.substr(0, stem.rfind('.')) + ".bin";
+    }
+    const char* cache = cache_s.c_str();
+    const long tcsv = mtime(csv), tbin = mtime(cache);
+    if (tcsv < 0 && tbin < 0) {
+      std::cerr << "[RUNCOND] no run-conditions dump (" << csv << "); conditions unavailable\n";
+      return false;
+    }
+    if (tcsv >= 0 && (tbin < 0 || tcsv > tbin || !current_layout(cache)) && !build(csv, cache)) return false;
+    return read_cache(cache);
+  }
+
+  const Conditions* find(int run) const {
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), run,
+                               [](const Conditions& c, int r){ return c.run < r; });
+    return (it != rows_.end() && it->run == run) ? &*it : nullptr;
+  }
+
+  // Grouping key over the listed fields (species, magnet, trigger, fill), "" if unknown.
+  std::string key(int run, const std::string& fields) const {
+    const Conditions* c = find(run);
+    if (!c) return "";
+    std::string k, f;
+    std::stringstream ss(fields);
+    while (std::getline(ss, f, ',')) {
+      f = trim(f);
+      if (f.empty()) continue;
+      if (!k.empty()) k += "|";
+      if      (f == "species") k += c->species;
+      else if (f == "magnet")  k += c->magnet;
+      else if (f == "trigger") k += c->trigger;
+      else if (f == "fill")    k += std::to_string(c->fill);
+    }
+    return k;
+  }
+
+  // "fill=...;species=...;magnet=...;trigger=..." for reports, "" if unknown
+  std::string describe(int run) const {
+    const Conditions* c = find(run);
+    if (!c) return "";
+    std::ostringstream os;
+    os << "fill=" << c->fill << ";species=" << c->species << ";magnet=" << c->magnet
+       << ";trigger=" << c->trigger;
+    return os.str();
+  }
+
+  // true when at least one run has a start time
+  bool has_start_times() const {
+    return std::any_of(rows_.begin(), rows_.end(), [](const Conditions& c){ return c.start_time > 0; });
+  }
+
+  size_t size() const { return rows_.size(); }
+  const std::vector<Conditions>& rows() const { return rows_; }
+
+private:
+  std::vector<Conditions> rows_;
+
+  static void copy_field(char* dst, size_t n, const std::string& src) {
+    std::strncpy(dst, src.c_str(), n - 1);
+    dst[n - 1] = 0;
+  }
+
+  static bool build(const char* csv, const char* cache) {
+    std::ifstream in(csv);
+    if (!in) return false;
+    std::vector<Conditions> rows;
+    std::string line;
+    bool header = true;
+    while (std::getline(in, line)) {
+      if (header) { header = false; continue; }
+      std::vector<std::string> t; std::string c; std::stringstream ss(line);
+      while (std::getline(ss, c, ',')) t.push_back(trim(c));
+      if (t.size() < 7) continue;
+      Conditions r;
+      try {
+        r.run = std::stoi(t[0]);
+        r.fill = t[1].empty() ? -1 : std::stoi(t[1]);
+        copy_field(r.species, sizeof(r.species), t[2]);
+        copy_field(r.magnet,  sizeof(r.magnet),  t[3]);
+        copy_field(r.trigger, sizeof(r.trigger), t[4]);
+        r.duration_s = t[5].empty() ? 0 : std::stod(t[5]);
+        r.events = t[6].empty() ? 0 : std::stoll(t[6]);
+        r.start_time = (t.size() > 7 && !t[7].empty()) ? std::stoll(t[7]) : 0;
+      } catch (...) { continue; }
+      rows.push_back(r);
+    }
+    std::sort(rows.begin(), rows.end(), [](const Conditions& a, const Conditions& b){ return a.run < b.run; });
+    rows.erase(std::unique(rows.begin(), rows.end(),
+                           [](const Conditions& a, const Conditions& b){ return a.run == b.run; }), rows.end());
+
+    std::string dir = cache;
+    size_t slash = dir.find_last_of('/');
+    if (slash != std::string::npos) gSystem->mkdir(dir.substr(0, slash).c_str(), kTRUE);
+    std::ofstream o(cache, std::ios::binary);
+    if (!o) return false;
+    unsigned long long n = rows.size();
+    o.write(kMagic, sizeof(kMagic));
+    o.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    if (n) o.write(reinterpret_cast<const char*>(rows.data()), n * sizeof(Conditions));
+    std::cout << "[RUNCOND] cached " << n << " runs from " << csv << " -> " << cache << "\n";
+    return true;
+  }
+
+  static bool current_layout(const char* cache) {
+    std::ifstream in(cache, std::ios::binary);
+    char magic[8];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+  }
+
+  bool read_cache(const char* cache) {
+    std::ifstream in(cache, std::ios::binary);
+    char magic[8]; unsigned long long n = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !in.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+      std::cerr << "[RUNCOND] invalid cache " << cache << "\n";
+      return false;
+    }
+    rows_.resize(n);
+    if (n && !in.read(reinterpret_cast<char*>(rows_.data()), n * sizeof(Conditions))) {
+      rows_.clear();
+      return false;
+    }
+    return !rows_.empty();
+  }
+};
+
+} // namespace runcond
+
+#endif // QA_RUN_CONDITIONS_H
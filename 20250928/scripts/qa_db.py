@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""qa_db.py — Indexed SQLite history of the QA outputs, with a query CLI.
+
+`ingest` loads the CSV tables of out/ into one SQLite file that accumulates
+across pipeline invocations, so ad-hoc questions need no custom macro and no
+re-reading of CSVs:
+
+  file_metrics        metric, run, segment, file, value, error, weight
+  run_metrics         metric, run, value, stat_err, entries, robust z columns
+  qc_batch            run × metric robust z / Shewhart / CUSUM / EWMA
+  verdicts            run, metric, subsystem, verdict, severity, ...
+  run_verdicts        run, verdict, n_good, n_suspect, n_bad, ...
+  subsystem_verdicts  view: worst verdict per run and subsystem (detector token
+                      anywhere in the metric name: cluster_size_intt_mean is INTT)
+  intt_ladder_health  run, dead_count, hot_count, median, total_ladders
+  intt_ladders        run, chip, ladder, count
+  mvtx_chip_clusters  run, layer, state, size, stave / chip range, chips
+
+Every table is indexed on run, and on (metric, run) where it has a metric.
+Sources are tracked by (size, mtime): only CSVs rewritten since the last
+ingest are read. A changed source replaces the rows of the runs (and metric)
+it contains, in one transaction with batched inserts; runs that are not in
+it are kept, so the database is the history over all processed batches.
+
+Usage:
+  python3 scripts/qa_db.py ingest [--db qa_history.db] [--out out]
+  python3 scripts/qa_db.py query  [--db qa_history.db] [--csv] "SELECT ..."
+  python3 scripts/qa_db.py schema [--db qa_history.db]
+
+Example — runs since 68500 with a hot MVTX L1 and INTT judged GOOD:
+  python3 scripts/qa_db.py query "SELECT m.run, m.value FROM run_metrics m
+    JOIN subsystem_verdicts s ON s.run = m.run AND s.subsystem = 'INTT'
+    WHERE m.metric = 'mvtx_hotchip_frac_l1' AND m.value > 0.02
+      AND m.run >= 68500 AND s.verdict = 'GOOD' ORDER BY m.run"
+"""
+import argparse, csv, glob, os, re, sqlite3, sys, time
+
+BATCH = 5000
+
+# detector tokens, matched anywhere in a metric name; first hit wins
+SUBSYSTEMS = ("mvtx", "intt", "tpc", "tpot", "emcal", "ihcal", "ohcal", "hcal", "mbd", "zdc", "sepd")
+
+# table -> (columns with SQL types, replacement key besides run)
+TABLES = {
+    "file_metrics": ([("metric", "TEXT"), ("run", "INTEGER"), ("segment", "INTEGER"), ("file", "TEXT"),
+                      ("value", "REAL"), ("error", "REAL"), ("weight", "REAL")], ("metric",)),
+    "run_metrics": ([("metric", "TEXT"), ("run", "INTEGER"), ("value", "REAL"), ("stat_err", "REAL"),
+                     ("entries", "REAL"), ("neighbors_median", "REAL"), ("neighbors_mad", "REAL"),
+                     ("z_local", "REAL"), ("is_outlier_weak", "INTEGER"), ("is_outlier_strong", "INTEGER")],
+                    ("metric",)),
+    "qc_batch": ([("run", "INTEGER"), ("metric", "TEXT"), ("value", "REAL"), ("z_local", "REAL"),
+                  ("is_outlier_weak", "INTEGER"), ("is_outlier_strong", "INTEGER"), ("z_global", "REAL"),
+                  ("shewhart_ooc", "INTEGER"), ("cusum_pos", "REAL"), ("cusum_neg", "REAL"),
+                  ("ewma", "REAL"), ("flag", "TEXT")], ("metric",)),
+    "verdicts": ([("run", "INTEGER"), ("metric", "TEXT"), ("subsystem", "TEXT"), ("verdict", "TEXT"),
+                  ("severity", "TEXT"), ("pattern", "TEXT"), ("cause", "TEXT"), ("action", "TEXT"),
+                  ("z_local", "REAL"), ("value", "REAL")], ()),
+    "run_verdicts": ([("run", "INTEGER"), ("verdict", "TEXT"), ("n_good", "INTEGER"), ("n_suspect", "INTEGER"),
+                      ("n_bad", "INTEGER"), ("worst_metric", "TEXT"), ("summary", "TEXT"), ("level", "TEXT"),
+                      ("conditions", "TEXT")], ()),
+    "intt_ladder_health": ([("run", "INTEGER"), ("dead_count", "INTEGER"), ("hot_count", "INTEGER"),
+                            ("median", "REAL"), ("total_ladders", "INTEGER")], ()),
+    "intt_ladders": ([("run", "INTEGER"), ("chip", "INTEGER"), ("ladder", "INTEGER"), ("count", "REAL")], ()),
+    "mvtx_chip_clusters": ([("run", "INTEGER"), ("layer", "INTEGER"), ("state", "TEXT"), ("size", "INTEGER"),
+                            ("stave_lo", "INTEGER"), ("stave_hi", "INTEGER"), ("chip_lo", "INTEGER"),
+                            ("chip_hi", "INTEGER"), ("chips", "TEXT")], ()),
+}
+
+SCHEMA_EXTRA = """
+CREATE TABLE IF NOT EXISTS sources (path TEXT PRIMARY KEY, tbl TEXT, size INTEGER, mtime_ns INTEGER,
+                                    rows INTEGER, ingested_at TEXT);
+CREATE INDEX IF NOT EXISTS idx_verdicts_subsystem_run ON verdicts (subsystem, run);
+CREATE VIEW IF NOT EXISTS subsystem_verdicts AS
+  SELECT run, subsystem,
+         CASE MAX(CASE verdict WHEN 'BAD' THEN 2 WHEN 'SUSPECT' THEN 1 ELSE 0 END)
+           WHEN 2 THEN 'BAD' WHEN 1 THEN 'SUSPECT' ELSE 'GOOD' END AS verdict,
+         COUNT(*) AS n_metrics
+  FROM verdicts GROUP BY run, subsystem;
+"""
+
+
+def subsystem_of(metric):
+    tokens = metric.lower().split("_")
+    return next((t.upper() for t in tokens if t in SUBSYSTEMS), tokens[0].upper())
+
+
+def open_db(path):
+    con = sqlite3.connect(path)
+    con.execute("PRAGMA journal_mode=WAL")
+    con.execute("PRAGMA synchronous=NORMAL")
+    # databases from before qc_batch.flag was TEXT hold only NULL flags: rebuild that table
+    if ("flag", "INTEGER") in [(r[1], r[2]) for r in con.execute("PRAGMA table_info(qc_batch)")]:
+        with con:
+            con.execute("DROP TABLE qc_batch")
+            con.execute("DELETE FROM sources WHERE tbl = 'qc_batch'")
+    for tbl, (cols, _) in TABLES.items():
+        con.execute(f"CREATE TABLE IF NOT EXISTS {tbl} ({', '.join(f'{c} {t}' for c, t in cols)})")
+        con.execute(f"CREATE INDEX IF NOT EXISTS idx_{tbl}_run ON {tbl} (run)")
+        if any(c == "metric" for c, _ in cols):
+            con.execute(f"CREATE INDEX IF NOT EXISTS idx_{tbl}_metric_run ON {tbl} (metric, run)")
+    con.executescript(SCHEMA_EXTRA)
+    if con.execute("PRAGMA user_version").fetchone()[0] < 1:
+        # version 0 filed subsystems by metric prefix (cluster_size_intt_mean under CLUSTER)
+        con.create_function("subsystem_of", 1, subsystem_of, deterministic=True)
+        with con:
+            con.execute("UPDATE verdicts SET subsystem = subsystem_of(metric) WHERE metric IS NOT NULL")
+            con.execute("PRAGMA user_version = 1")
+    return con
+
+
+def header_of(path):
+    with open(path, newline="") as f:
+        return f.readline().strip().split(",")
+
+
+def sources(out):
+    """(path, table, extra columns) for every known CSV in out/."""
+    for p in sorted(glob.glob(os.path.join(out, "metrics_*.csv"))):
+        base, hdr = os.path.basename(p), header_of(p)
+        if hdr[:3] == ["run", "segment", "file"]:
+            yield p, "file_metrics", {"metric": base[len("metrics_"):-len(".csv")]}
+        elif base.endswith("_perrun.csv") and hdr[:2] == ["run", "value"]:
+            yield p, "run_metrics", {"metric": base[len("metrics_"):-len("_perrun.csv")]}
+    for name, tbl in (("qc_batch.csv", "qc_batch"), ("verdicts.csv", "verdicts"),
+                      ("run_verdicts.csv", "run_verdicts"), ("intt_ladder_health.csv", "intt_ladder_health"),
+                      ("mvtx_chip_clusters.csv", "mvtx_chip_clusters")):
+        p = os.path.join(out, name)
+        if os.path.isfile(p):
+            yield p, tbl, {}
+    for p in sorted(glob.glob(os.path.join(out, "intt_ladder_counts_run*.csv"))):
+        m = re.search(r"run(\d+)\.csv$", p)
+        if m:
+            yield p, "intt_ladders", {"run": m.group(1)}
+
+
+def convert(v, typ):
+    if v is None or v == "":
+        return None
+    if typ == "TEXT":
+        return v
+    try:
+        x = float(v)
+    except ValueError:
+        return None
+    if x != x:
+        return None
+    return int(x) if typ == "INTEGER" and x == int(x) else x
+
+
+def rows_of(path, tbl, extra):
+    cols, _ = TABLES[tbl]
+    with open(path, newline="") as f:
+        for rec in csv.DictReader(f):
+            rec.update(extra)
+            if tbl == "verdicts" and rec.get("metric"):
+                rec["subsystem"] = subsystem_of(rec["metric"])
+            row = tuple(convert(rec.get(c), t) for c, t in cols)
+            if row[[c for c, _ in cols].index("run")] is not None:
+                yield row
+
+
+def ingest(con, out):
+    t0, nsrc, nrows, skipped = time.time(), 0, 0, 0
+    seen = dict(con.execute("SELECT path, size || ':' || mtime_ns FROM sources"))
+    for path, tbl, extra in sources(out):
+        st = os.stat(path)
+        sig = f"{st.st_size}:{st.st_mtime_ns}"
+        if seen.get(path) == sig:
+            skipped += 1
+            continue
+        cols, key = TABLES[tbl]
+        names = [c for c, _ in cols]
+        krun = names.index("run")
+        kcols = [names.index(k) for k in key]
+        rows = list(rows_of(path, tbl, extra))
+        keys = sorted({tuple(r[i] for i in kcols) + (r[krun],) for r in rows}, key=str)
+        where = " AND ".join(f"{k} = ?" for k in key + ("run",))
+        insert = f"INSERT INTO {tbl} ({', '.join(names)}) VALUES ({', '.join('?' * len(names))})"
+        with con:   # one transaction per source: old rows of its runs out, new rows in
+            con.executemany(f"DELETE FROM {tbl} WHERE {where}", keys)
+            for i in range(0, len(rows), BATCH):
+                con.executemany(insert, rows[i:i + BATCH])
+            con.execute("INSERT OR REPLACE INTO sources VALUES (?, ?, ?, ?, ?, datetime('now'))",
+                        (path, tbl, st.st_size, st.st_mtime_ns, len(rows)))
+        nsrc += 1
+        nrows += len(rows)
+    con.execute("PRAGMA optimize")
+    print(f"[DB] {nsrc} changed sources ({nrows} rows), {skipped} unchanged, "
+          f"{1000 * (time.time() - t0):.0f} ms")
+
+
+def query(con, sql, as_csv):
+    t0 = time.time()
+    cur = con.execute(sql)
+    rows = cur.fetchall()
+    names = [d[0] for d in cur.description] if cur.description else []
+    if as_csv:
+        w = csv.writer(sys.stdout)
+        w.writerow(names)
+        w.writerows(rows)
+    elif names:
+        text = [["NULL" if v is None else str(v) for v in r] for r in rows]
+        width = [max([len(n)] + [len(r[i]) for r in text]) for i, n in enumerate(names)]
+        print("  ".join(n.ljust(w) for n, w in zip(names, width)))
+        print("  ".join("-" * w for w in width))
+        for r in text:
+            print("  ".join(v.ljust(w) for v, w in zip(r, width)))
+    print(f"({len(rows)} rows, {1000 * (time.time() - t0):.1f} ms)", file=sys.stderr)
+
+
+def schema(con):
+    for name, kind in con.execute("SELECT name, type FROM sqlite_master "
+                                  "WHERE type IN ('table', 'view') AND name NOT LIKE 'sqlite_%' "
+                                  "ORDER BY type, name"):
+        cols = [r[1] for r in con.execute(f"PRAGMA table_info({name})")]
+        n = con.execute(f"SELECT COUNT(*) FROM {name}").fetchone()[0]
+        print(f"{name} ({kind}, {n} rows): {', '.join(cols)}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="SQLite history of the QA outputs")
+    ap.add_argument("cmd", choices=["ingest", "query", "schema"])
+    ap.add_argument("sql", nargs="?")
+    ap.add_argument("--db", default=os.environ.get("QA_DB", "qa_history.db"))
+    ap.add_argument("--out", default="out")
+    ap.add_argument("--csv", action="store_true", help="query result as CSV")
+    a = ap.parse_intermixed_args()
+    if a.cmd == "query" and not a.sql:
+        ap.error("query needs an SQL statement")
+    con = open_db(a.db)
+    try:
+        if a.cmd == "ingest":
+            ingest(con, a.out)
+        elif a.cmd == "query":
+            query(con, a.sql, a.csv)
+        else:
+            schema(con)
+    except sqlite3.Error as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
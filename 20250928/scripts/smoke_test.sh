@@ -103,7 +103,7 @@ fi
 # Check verdict outputs
 echo ""
 echo "--- Verdict outputs ---"
-for vfile in out/verdicts.csv out/run_verdicts.csv out/VERDICT.md; do
+for vfile in out/verdicts.csv out/run_verdicts.csv out/VERDICT.md out/verdicts/pages.csv; do
     if [ -f "$vfile" ]; then
         rows=$(wc -l < "$vfile" | tr -d ' ')
         echo "[ OK ] $vfile: $rows lines"
@@ -162,6 +162,33 @@ else
     WARN=$((WARN + 1))
 fi
 
+# Check the QA database: qc_batch flags must survive ingest and be queryable
+echo ""
+echo "--- QA database ---"
+if ! command -v python3 >/dev/null 2>&1; then
+    echo "[WARN] python3 not found, QA database not checked"
+    WARN=$((WARN + 1))
+elif [ -f "out/qc_batch.csv" ]; then
+    tmpdb=$(mktemp -d)
+    python3 scripts/qa_db.py ingest --db "$tmpdb/qa.db" --out out > /dev/null || true
+    nflag=$(awk -F',' 'NR > 1 && ($NF == "WARN" || $NF == "PASS")' out/qc_batch.csv | wc -l | tr -d ' ')
+    nwarn=$(awk -F',' 'NR > 1 && $NF == "WARN"' out/qc_batch.csv | wc -l | tr -d ' ')
+    dbflag=$(python3 scripts/qa_db.py query --db "$tmpdb/qa.db" --csv \
+        "SELECT COUNT(*) FROM qc_batch WHERE flag IN ('WARN', 'PASS')" 2>/dev/null | tail -1 | tr -d "\r")
+    dbwarn=$(python3 scripts/qa_db.py query --db "$tmpdb/qa.db" --csv \
+        "SELECT COUNT(*) FROM qc_batch WHERE flag = 'WARN'" 2>/dev/null | tail -1 | tr -d "\r")
+    rm -rf "$tmpdb"
+    if [ "$nflag" -gt 0 ] && [ "$dbflag" = "$nflag" ] && [ "$dbwarn" = "$nwarn" ]; then
+        echo "[ OK ] qc_batch by flag: $dbflag flagged rows, $dbwarn WARN"
+    else
+        echo "[FAIL] qc_batch by flag: db has $dbflag flagged ($dbwarn WARN), csv has $nflag ($nwarn WARN)"
+        FAIL=$((FAIL + 1))
+    fi
+else
+    echo "[WARN] out/qc_batch.csv: not found (robust step may not have run)"
+    WARN=$((WARN + 1))
+fi
+
 # Check dashboard
 echo ""
 echo "--- Dashboard ---"
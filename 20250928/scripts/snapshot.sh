@@ -0,0 +1,220 @@
+#!/usr/bin/env bash
+# snapshot.sh — Content-addressed, immutable snapshots of out/.
+#
+# Each snapshot records every file of out/ by SHA-256 in a manifest; the file
+# bodies live once in an object store, so unchanged outputs cost nothing in
+# later snapshots. A snapshot is keyed by the inputs that produced it:
+#   list   — the file list plus size/mtime of every ROOT file it names
+#   conf   — metrics.conf
+#   thresh — thresholds CSV
+#   macros — macros/*.C, macros/*.h and the Makefile
+# The snapshot id is <key>-<content>: re-snapshotting identical outputs of the
+# same inputs is a no-op, while the same key with different outputs (e.g. a
+# non-deterministic step) gets its own snapshot.
+#
+# Hashes are cached by (path, size, mtime) in $SNAP_DIR/.hashcache, so only
+# files rewritten since the last snapshot are hashed again. The mtime has
+# sub-second resolution, so a same-size rewrite within one second is noticed.
+#
+# Layout:
+#   $SNAP_DIR/objects/<h:0:2>/<h>   read-only file bodies
+#   $SNAP_DIR/<id>/MANIFEST         sha256  size  path   (sorted by path)
+#   $SNAP_DIR/<id>/KEY              list=, conf=, thresh=, macros=, key=
+#   $SNAP_DIR/<id>/INFO             date, git revision, file count, stamp
+#
+# Usage:
+#   ./scripts/snapshot.sh create  [list] [conf] [thresh]
+#   ./scripts/snapshot.sh list
+#   ./scripts/snapshot.sh show    <id>
+#   ./scripts/snapshot.sh restore <id> [dest=out]
+#   ./scripts/snapshot.sh diff    <id_a> <id_b|out>
+# Ids may be abbreviated to any unique prefix. restore overwrites the files of
+# the manifest and leaves other files in dest alone (restore into an empty
+# directory for an exact copy). SNAP_DIR defaults to snapshots, OUT_DIR to out.
+
+set -euo pipefail
+
+SNAP_DIR="${SNAP_DIR:-snapshots}"
+OUT_DIR="${OUT_DIR:-out}"
+CACHE="$SNAP_DIR/.hashcache"
+
+die() { echo "[ERROR] $*" >&2; exit 1; }
+
+if command -v sha256sum >/dev/null; then SHA="sha256sum"; else SHA="shasum -a 256"; fi
+sha() { $SHA "$@"; }
+
+# size and mtime with nanoseconds: GNU stat (%y), else BSD stat (%Fm)
+file_sig() { stat -c '%s %y' "$1" 2>/dev/null || stat -f '%z %Fm' "$1"; }
+
+# Manifest of a directory on stdout: sha256  size  path (paths relative to dir)
+manifest_of() {
+    local dir="$1"
+    mkdir -p "$SNAP_DIR"
+    touch "$CACHE"
+    local tmp; tmp=$(mktemp)
+    (cd "$dir" && find . -type f ! -path './_spill/*' | sed 's|^\./||' | LC_ALL=C sort) |
+    while IFS= read -r rel; do
+        read -r size mtime < <(file_sig "$dir/$rel")
+        printf '%s\t%s\t%s\t%s\n' "$dir/$rel" "$size" "$mtime" "$rel"
+    done > "$tmp"
+    # reuse cached hashes for unchanged (path, size, mtime); hash the rest
+    awk -F'\t' 'FILENAME == ARGV[1] { h[$1"\t"$2"\t"$3]=$4; next }
+         { k=$1"\t"$2"\t"$3; print ((k in h) ? h[k] : "-")"\t"$0 }' "$CACHE" "$tmp" |
+    while IFS=$'\t' read -r h path size mtime rel; do
+        if [ "$h" = "-" ]; then
+            h=$(sha "$path" | cut -d' ' -f1)
+            printf '%s\t%s\t%s\t%s\n' "$path" "$size" "$mtime" "$h" >> "$CACHE.new"
+        fi
+        printf '%s  %s  %s\n' "$h" "$size" "$rel"
+    done
+    rm -f "$tmp"
+}
+
+# Fold hashes computed by manifest_of into the cache, latest entry per path
+merge_cache() {
+    [ -f "$CACHE.new" ] || return 0
+    cat "$CACHE" "$CACHE.new" | awk -F'\t' '{ row[$1]=$0 } END { for (p in row) print row[p] }' > "$CACHE.tmp"
+    mv "$CACHE.tmp" "$CACHE"
+    rm -f "$CACHE.new"
+}
+
+input_key() {
+    local list="$1" conf="$2" thresh="$3"
+    local k_list k_conf k_thresh k_macros
+    if [ -f "$list" ]; then
+        k_list=$( { cat "$list"; grep -v '^\s*#' "$list" | while IFS= read -r f; do
+                    if [ -f "$f" ]; then echo "$f $(file_sig "$f")"; fi; done; } | sha | cut -d' ' -f1)
+    else
+        k_list=none
+    fi
+    k_conf=$( [ -f "$conf" ] && sha "$conf" | cut -d' ' -f1 || echo none)
+    k_thresh=$( [ -f "$thresh" ] && sha "$thresh" | cut -d' ' -f1 || echo none)
+    k_macros=$(ls macros/*.C macros/*.h Makefile 2>/dev/null | LC_ALL=C sort | xargs $SHA | sha | cut -d' ' -f1)
+    echo "list=$k_list"
+    echo "conf=$k_conf"
+    echo "thresh=$k_thresh"
+    echo "macros=$k_macros"
+    echo "key=$(printf '%s\n' "$k_list" "$k_conf" "$k_thresh" "$k_macros" | sha | cut -d' ' -f1)"
+}
+
+resolve() {
+    local want="$1" hits
+    [ -d "$SNAP_DIR/$want" ] && [ -f "$SNAP_DIR/$want/MANIFEST" ] && { echo "$want"; return; }
+    hits=$(ls -1 "$SNAP_DIR" 2>/dev/null | grep "^$want" | grep -v '^objects$' || true)
+    [ -n "$hits" ] || die "no snapshot matches '$want'"
+    [ "$(echo "$hits" | wc -l)" -eq 1 ] || die "'$want' is ambiguous: $(echo $hits)"
+    echo "$hits"
+}
+
+cmd_create() {
+    local list="${1:-lists/files.txt}" conf="${2:-metrics.conf}" thresh="${3:-configs/thresholds.csv}"
+    [ -d "$OUT_DIR" ] || die "$OUT_DIR does not exist"
+    mkdir -p "$SNAP_DIR/objects"
+
+    local tmp_m tmp_k; tmp_m=$(mktemp); tmp_k=$(mktemp)
+    manifest_of "$OUT_DIR" > "$tmp_m"
+    merge_cache
+    input_key "$list" "$conf" "$thresh" > "$tmp_k"
+
+    local key content id
+    key=$(sed -n 's/^key=//p' "$tmp_k")
+    content=$(sha "$tmp_m" | cut -d' ' -f1)
+    id="${key:0:12}-${content:0:8}"
+    if [ -d "$SNAP_DIR/$id" ]; then
+        echo "[SNAP] unchanged: $id already holds these outputs"
+        rm -f "$tmp_m" "$tmp_k"
+        return
+    fi
+
+    # store new bodies; existing objects are shared with earlier snapshots
+    local added=0 bytes=0 h size rel obj
+    while read -r h size rel; do
+        obj="$SNAP_DIR/objects/${h:0:2}/$h"
+        [ -f "$obj" ] && continue
+        mkdir -p "${obj%/*}"
+        cp "$OUT_DIR/$rel" "$obj.tmp" && chmod 444 "$obj.tmp" && mv "$obj.tmp" "$obj"
+        added=$((added + 1)); bytes=$((bytes + size))
+    done < "$tmp_m"
+
+    mkdir -p "$SNAP_DIR/$id.tmp"
+    mv "$tmp_m" "$SNAP_DIR/$id.tmp/MANIFEST"
+    mv "$tmp_k" "$SNAP_DIR/$id.tmp/KEY"
+    {
+        echo "date=$(date +"%Y-%m-%d %H:%M:%S")"
+        echo "git=$(git rev-parse --short HEAD 2>/dev/null || echo NA)"
+        echo "files=$(wc -l < "$SNAP_DIR/$id.tmp/MANIFEST" | tr -d ' ')"
+        echo "list=$list"
+        echo "conf=$conf"
+        echo "thresh=$thresh"
+        [ -f "$OUT_DIR/_stamp.txt" ] && sed 's/^/stamp./' "$OUT_DIR/_stamp.txt"
+    } > "$SNAP_DIR/$id.tmp/INFO"
+    chmod 444 "$SNAP_DIR/$id.tmp"/*
+    mv "$SNAP_DIR/$id.tmp" "$SNAP_DIR/$id"
+    echo "[SNAP] created $id ($(sed -n 's/^files=//p' "$SNAP_DIR/$id/INFO") files, $added new objects, $bytes bytes stored)"
+}
+
+cmd_list() {
+    [ -d "$SNAP_DIR" ] || { echo "[SNAP] no snapshots in $SNAP_DIR"; return; }
+    printf '%-21s  %-19s  %6s  %s\n' "id" "date" "files" "runs"
+    for d in "$SNAP_DIR"/*/; do
+        d=${d%/}; [ -f "$d/INFO" ] || continue
+        local info="$d/INFO"
+        printf '%-21s  %-19s  %6s  %s-%s\n' "${d##*/}" \
+            "$(sed -n 's/^date=//p' "$info")" "$(sed -n 's/^files=//p' "$info")" \
+            "$(sed -n 's/^stamp.run_min=//p' "$info")" "$(sed -n 's/^stamp.run_max=//p' "$info")"
+    done | sort -k2,3
+    echo "[SNAP] object store: $(find "$SNAP_DIR/objects" -type f | wc -l | tr -d ' ') objects, $(du -sh "$SNAP_DIR/objects" | cut -f1)"
+}
+
+cmd_show() {
+    local id; id=$(resolve "${1:?snapshot id required}")
+    cat "$SNAP_DIR/$id/INFO" "$SNAP_DIR/$id/KEY"
+}
+
+cmd_restore() {
+    local id; id=$(resolve "${1:?snapshot id required}")
+    local dest="${2:-$OUT_DIR}" n=0 h size rel
+    mkdir -p "$dest"
+    while read -r h size rel; do
+        mkdir -p "$(dirname "$dest/$rel")"
+        cp -f "$SNAP_DIR/objects/${h:0:2}/$h" "$dest/$rel"
+        chmod u+w "$dest/$rel"
+        n=$((n + 1))
+    done < "$SNAP_DIR/$id/MANIFEST"
+    echo "[SNAP] restored $id into $dest ($n files)"
+}
+
+cmd_diff() {
+    local a b ma mb tmp=""
+    a=$(resolve "${1:?two snapshots (or a snapshot and 'out') required}")
+    ma="$SNAP_DIR/$a/MANIFEST"
+    if [ "${2:-out}" = "out" ]; then
+        b="$OUT_DIR"; tmp=$(mktemp); manifest_of "$OUT_DIR" > "$tmp"; merge_cache; mb="$tmp"
+    else
+        b=$(resolve "$2"); mb="$SNAP_DIR/$b/MANIFEST"
+    fi
+    echo "--- $a"
+    echo "+++ $b"
+    if cmp -s <(awk '{print $1"  "$3}' "$ma") <(awk '{print $1"  "$3}' "$mb"); then
+        echo "[SNAP] identical"
+    else
+        # path -> hash on each side; report A(dded), D(eleted), M(odified)
+        awk 'FILENAME == ARGV[1] { a[$3]=$1; next }
+             { if (!($3 in a)) print "A  "$3; else if (a[$3] != $1) print "M  "$3; delete a[$3] }
+             END { for (p in a) print "D  "p }' "$ma" "$mb" | sort -k2
+    fi
+    if [ -n "$tmp" ]; then
+        rm -f "$tmp"
+    elif [ "$(sed -n 's/^key=//p' "$SNAP_DIR/$a/KEY")" != "$(sed -n 's/^key=//p' "$SNAP_DIR/$b/KEY")" ]; then
+        echo "[SNAP] input keys differ (see '$0 show' for list/conf/thresh/macros)"
+    fi
+}
+
+case "${1:-}" in
+    create)  shift; cmd_create "$@" ;;
+    list)    shift; cmd_list ;;
+    show)    shift; cmd_show "$@" ;;
+    restore) shift; cmd_restore "$@" ;;
+    diff)    shift; cmd_diff "$@" ;;
+    *) sed -n '2,/^$/p' "$0" | sed 's/^# \{0,1\}//'; exit 1 ;;
+esac
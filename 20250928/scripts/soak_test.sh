@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+# soak_test.sh — Memory soak test: thousands of mock runs in one ROOT process.
+# Builds a scratch copy of the pipeline, generates mock runs, runs the core
+# stages once for the per-run tables, then macros/soak_driver.C re-runs the
+# plotting stages round after round in a single process and checks that RSS
+# stays flat after warm-up. The RSS trace is copied to out/soak_rss.csv.
+#
+# Usage: ./scripts/soak_test.sh [nruns=2000] [chunk=50] [tol_mb=20]
+# Environment: ROOTCMD (default "root -l -b -q"), KEEP=1 keeps the scratch dir
+# Exit codes: 0 = pass, 1 = RSS grew beyond tol_mb (or a step failed)
+
+set -euo pipefail
+
+NRUNS="${1:-2000}"
+CHUNK="${2:-50}"
+TOL_MB="${3:-20}"
+ROOTCMD="${ROOTCMD:-root -l -b -q}"
+HERE="$(pwd)"
+WORK="$(mktemp -d "${TMPDIR:-/tmp}/qa_soak.XXXXXX")"
+if [ "${KEEP:-0}" != "1" ]; then trap 'rm -rf "$WORK"' EXIT; fi
+
+echo "=== QA Soak Test ==="
+echo "Runs: $NRUNS  chunk: $CHUNK  tolerance: $TOL_MB MB"
+echo "Scratch: $WORK"
+
+cp -r macros configs metrics.conf Makefile "$WORK/"
+mkdir -p "$WORK/lists" "$WORK/out"
+cd "$WORK"
+
+echo ""
+echo "--- Mock runs ---"
+$ROOTCMD "macros/make_mock_inputs.C(\"data/\",\"lists/soak_files.txt\",$NRUNS,\"lists/soak_labels.csv\",\"lists/soak_run_conditions.csv\")" > soak_setup.log 2>&1
+echo "[ OK ] $(grep -c . lists/soak_files.txt) mock runs"
+
+echo ""
+echo "--- Core stages (per-run tables) ---"
+make core LIST=lists/soak_files.txt RUNCOND=lists/soak_run_conditions.csv ROOTCMD="$ROOTCMD" >> soak_setup.log 2>&1
+echo "[ OK ] make core (log: soak_setup.log)"
+
+echo ""
+echo "--- Soak ---"
+rc=0
+$ROOTCMD "macros/soak_driver.C(\"lists/soak_files.txt\",$CHUNK,5,$TOL_MB)" 2>&1 | grep '^\[SOAK\]' || rc=$?
+[ -f out/soak_rss.csv ] && mkdir -p "$HERE/out" && cp out/soak_rss.csv "$HERE/out/soak_rss.csv"
+
+echo ""
+echo "=== Summary ==="
+if [ "$rc" -ne 0 ]; then
+    echo "RESULT: FAIL (see out/soak_rss.csv)"
+    exit 1
+fi
+echo "RESULT: PASS"